@@ -0,0 +1,127 @@
+--- Analyze departure traces written by the software rate limiter, see software-ratecontrol.lua
+local ffi  = require "ffi"
+local hist = require "histogram"
+local log  = require "log"
+
+ffi.cdef[[
+	struct rate_limiter_trace_header {
+		char magic[8];
+		uint32_t version;
+		uint32_t entry_size;
+		uint64_t tsc_hz;
+		uint64_t seed;
+		uint64_t entries;
+		uint64_t dropped;
+	};
+
+	struct rate_limiter_trace_entry {
+		uint64_t target;
+		int32_t error;
+		uint32_t retries;
+	};
+]]
+
+local HEADER_SIZE = ffi.sizeof("struct rate_limiter_trace_header")
+local ENTRY_SIZE = ffi.sizeof("struct rate_limiter_trace_entry")
+local CHUNK_SIZE = 2^16
+
+function configure(parser)
+	parser:description("Compute the gap error distribution of a rate limiter trace.")
+	parser:argument("trace", "Trace file written by the rate limiter.")
+	parser:argument("compare", "Second trace, check whether both follow the same schedule."):args("?")
+	parser:option("-o --output", "Prefix for the histogram files."):default("trace")
+end
+
+-- calls fn(targetNs, actualNs, retries) for each entry
+local function readTrace(file, fn)
+	local f = io.open(file, "rb")
+	if not f then
+		log:fatal("Could not open %s.", file)
+	end
+	local data = f:read(HEADER_SIZE)
+	local header = data and #data == HEADER_SIZE and ffi.cast("struct rate_limiter_trace_header*", data)
+	if not header or ffi.string(header.magic) ~= "MGTRACE" or header.entry_size ~= ENTRY_SIZE then
+		log:fatal("%s is not a rate limiter trace.", file)
+	end
+	local nsPerCycle = 10^9 / tonumber(header.tsc_hz)
+	local first
+	while true do
+		local chunk = f:read(CHUNK_SIZE * ENTRY_SIZE)
+		if not chunk then
+			break
+		end
+		local entries = ffi.cast("struct rate_limiter_trace_entry*", chunk)
+		for i = 0, math.floor(#chunk / ENTRY_SIZE) - 1 do
+			local e = entries[i]
+			-- relative to the first packet to keep the precision of doubles
+			first = first or e.target
+			local target = tonumber(e.target - first) * nsPerCycle
+			fn(target, target + e.error * nsPerCycle, e.retries)
+		end
+	end
+	f:close()
+	return {
+		entries = tonumber(header.entries),
+		dropped = tonumber(header.dropped),
+		seed = tonumber(header.seed)
+	}
+end
+
+local function analyze(file, output)
+	local gapError, lateness = hist:new(), hist:new()
+	local retries, retried = 0, 0
+	local lastTarget, lastActual
+	local info = readTrace(file, function(target, actual, r)
+		if lastTarget then
+			gapError:update(math.floor((actual - lastActual) - (target - lastTarget) + 0.5))
+		end
+		lateness:update(math.floor(actual - target + 0.5))
+		lastTarget, lastActual = target, actual
+		if r > 0 then
+			retries = retries + r
+			retried = retried + 1
+		end
+	end)
+	log:info("%s: %d packets, %d dropped trace entries, seed %d", file, info.entries, info.dropped, info.seed)
+	log:info("%d packets needed %d retries of rte_eth_tx_burst", retried, retries)
+	if info.dropped > 0 then
+		log:warn("Trace is incomplete, gaps around dropped entries are included in the gap error.")
+	end
+	log:info("Gap error (actual - target inter-departure time) in ns:")
+	gapError:print()
+	gapError:save(output .. "-gap-error.csv")
+	log:info("Lateness (actual - target departure time) in ns:")
+	lateness:print()
+	lateness:save(output .. "-lateness.csv")
+end
+
+local function compareSchedules(file1, file2)
+	local targets = {}
+	readTrace(file1, function(target)
+		targets[#targets + 1] = target
+	end)
+	local i, mismatch = 0, nil
+	readTrace(file2, function(target)
+		i = i + 1
+		-- tsc frequencies of different runs might differ slightly, allow 1 ns
+		if not mismatch and (not targets[i] or math.abs(targets[i] - target) > 1) then
+			mismatch = i
+		end
+	end)
+	if i ~= #targets then
+		log:warn("Traces have different lengths: %d and %d packets.", #targets, i)
+	end
+	if mismatch then
+		log:warn("Schedules differ, starting with packet %d.", mismatch)
+	else
+		log:info("Schedules are identical.")
+	end
+end
+
+function master(args)
+	analyze(args.trace, args.output)
+	if args.compare then
+		analyze(args.compare, args.output .. "-compare")
+		compareSchedules(args.trace, args.compare)
+	end
+end
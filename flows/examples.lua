@@ -36,6 +36,17 @@ Flow{"qos-background", Packet.Udp{
 	rate = 4000
 }
 
+Flow{"imix", Packet.Udp{
+		ethSrc = txQueue(),
+		ethDst = arp("10.1.0.10"),
+		ip4Src = ip"10.0.0.10",
+		ip4Dst = ip"10.1.0.10",
+		udpSrc = 1234,
+		udpDst = 319,
+		pktLength = imix"simple"
+	}
+}
+
 Flow{"tcp-syn-flood4", Packet.Tcp4{
 		ethSrc = txQueue(),
 		ethDst = mac"12:34:56:78:90:00",
@@ -37,6 +37,10 @@ local function _print_debug(args)
 
 	print(string.format("Flow: \27[1m%s\27[0m\n", fparse.name))
 
+	if flow.packet.sizes then
+		print(string.format("Packet sizes: %s\n", tostring(flow.packet.sizes)))
+	end
+
 	local dv = flow.packet.dynvars
 	if #dv > 0 then
 		local dynvar_out = {"Dynamic: "}
@@ -18,6 +18,7 @@ setmetatable(mod.env, { __index = _safe_methods })
 
 require "configenv.range" (mod.env)
 require "configenv.util" (mod.env)
+require "configenv.sizes" (mod.env)
 
 for _,v in pairs(require "dependencies") do
 	v.env(mod.env)
@@ -0,0 +1,47 @@
+local Sizes = require "flow.sizes"
+
+return function(env)
+	local function _check(result, msg)
+		env.error:assert(result, msg)
+		return result
+	end
+
+	function env.imix(name)
+		local t = type(name)
+		if t ~= "string" and t ~= "nil" then
+			env.error("Function 'imix': string expected, got %s.", t)
+			return
+		end
+
+		return _check(Sizes.imix(name))
+	end
+
+	function env.sizeMix(tbl)
+		local t = type(tbl)
+		if t ~= "table" then
+			env.error("Function 'sizeMix': table expected, got %s.", t)
+			return
+		end
+
+		local entries = {}
+		for size, weight in pairs(tbl) do
+			table.insert(entries, { size, weight })
+		end
+		return _check(Sizes.new(entries))
+	end
+
+	function env.sizeCdf(filename)
+		local t = type(filename)
+		if t ~= "string" then
+			env.error("Function 'sizeCdf': string expected, got %s.", t)
+			return
+		end
+
+		-- relative paths start at the directory of the config file
+		if env._FILE and not string.find(filename, "^/") then
+			filename = string.gsub(env._FILE, "[^/]*$", "") .. filename
+		end
+
+		return _check(Sizes.fromCdf(filename))
+	end
+end
@@ -1,5 +1,8 @@
 local device = require "device"
 
+-- tx descriptors per queue, also bounds the mbufs held by the driver
+local txDescs = 512
+
 local devicesClass = {}
 
 function devicesClass:reserveTx(tx)
@@ -37,14 +40,14 @@ function devicesClass:configure()
 	for i,v in pairs(self) do
 		local txq, rxq = v.txq, v.rxq
 		txq, rxq = (txq == 0) and 1 or txq, (rxq == 0) and 1 or rxq
-		v.dev = device.config{ port = i, rxQueues = rxq, rssQueues = v.rsq, txQueues = txq }
+		v.dev = device.config{ port = i, rxQueues = rxq, rssQueues = v.rsq, txQueues = txq, txDescs = txDescs }
 	end
 
 	device.waitForLinks()
 end
 
 
-local mod = {}
+local mod = { txDescs = txDescs }
 
 function mod.newDevmgr()
 	return setmetatable({ }, {
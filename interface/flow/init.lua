@@ -118,7 +118,8 @@ function mod.crawlDirectory(baseDir, silent)
 	baseDir = baseDir or "flows"
 	for f in lfs.dir(baseDir) do
 		f = baseDir .. "/" .. f
-		if lfs.attributes(f, "mode") == "file" then
+		-- other files, e.g. size distributions, may be placed next to the flows
+		if lfs.attributes(f, "mode") == "file" and string.find(f, "%.lua$") then
 			configenv:parseFile(f)
 		end
 	end
@@ -187,7 +188,12 @@ function mod.getInstance(name, file, cli_options, overwrites, properties, silent
 	for i, opt in pairs(options) do
 		error:setPrefix("Option '%s': ", i)
 		local v = cli_options[i] or flow.proto.options[i]
-		results[i] = opt.parse(flow, v, error)
+		local result, extra = opt.parse(flow, v, error)
+		results[i] = result
+		-- additional results derived from the option, e.g. the unit of the rate
+		for k, x in pairs(extra or {}) do
+			results[k] = x
+		end
 	end
 
 	-- prepare flow
@@ -14,7 +14,7 @@ function Flow:prepare(error, final)
 	self.isDynamic = type(self.updatePacket) ~= "nil"
 	self.packet:prepare(error, self, final)
 
-	if self:option "uniquePayload" then
+	if self:option "uniquePayload" and not self.packet.sizes then
 		local p0, p1, p2, p3 = separateUid(self:option "uid")
 		local size = self:packetSize()
 		self.setPayload = function(pkt)
@@ -66,6 +66,34 @@ function Flow:packetSize(checksum)
 	return (self.packet.fillTbl.pktLength or 0) + (checksum and 4 or 0)
 end
 
+function Flow:meanPacketSize(checksum)
+	local sizes = self.packet.sizes
+	local size = sizes and sizes.mean or self.packet.fillTbl.pktLength or 0
+	return size + (checksum and 4 or 0)
+end
+
+-- returns nil for flows with a fixed packet size
+function Flow:newSizeDistribution(linkSpeed)
+	local sizes = self.packet.sizes
+	if not sizes then return end
+
+	local dist = sizes:newNative(self:option "seed")
+	for _,v in ipairs(sizes.lengthFields(self.packet.proto)) do
+		dist:addLengthField(v[1], v[2])
+	end
+
+	if self:option "uniquePayload" then
+		dist:setUid(self:option "uid")
+	end
+
+	-- byte rates are held by per packet delays, packet rates by a fixed delay
+	if linkSpeed and self:option "rate" and not self:option "rateInPackets" then
+		dist:setRate(linkSpeed, self:option "rate")
+	end
+
+	return dist
+end
+
 function Flow:clone(properties)
 	local clone = setmetatable({}, Flow)
 
@@ -83,7 +111,7 @@ end
 function Flow:getDelay()
 	local cbr = self.results.rate
 	if cbr then
-		local psize = self:packetSize(true)
+		local psize = self:meanPacketSize(true)
 		-- cbr      => mbit/s        => bit/1000ns
 		-- psize    => b/p           => 8bit/p
 		return 8000 * psize / cbr -- => ns/p
@@ -4,6 +4,7 @@ local ffi    = require "ffi"
 local dependencies = require "dependencies"
 
 local Dynvars = require "flow.dynvars"
+local Sizes = require "flow.sizes"
 
 local Packet = {}
 Packet.__index = Packet
@@ -32,6 +33,10 @@ function Packet.new(proto, tbl, error)
 		if pkt then
 			if type(v) == "function" then
 				self.fillTbl[i] = self.dynvars:add(pkt, var, v).value
+			elseif i == "pktLength" and Sizes.isSizes(v) then
+				-- buffers are filled using the largest size, others are set when sending
+				self.sizes = v
+				self.fillTbl[i] = v.max
 			elseif type(v) == "table" then
 				local ft = error:assert(v[1] and dependencies[v[1]],
 					"Invalid table passed to field '%s'.", i)
@@ -66,6 +71,10 @@ function Packet:inherit(other)
 		self.dynvars:inherit(other.dynvars, self.fillTbl)
 		_inherit_depvars(self, other)
 
+		if not self.fillTbl.pktLength then
+			self.sizes = other.sizes
+		end
+
 		for i,v in pairs(other.fillTbl) do
 			if not self.fillTbl[i] then
 				self.fillTbl[i] = v
@@ -84,6 +93,17 @@ function Packet:prepare(error, flow, final)
 			self.proto, self.minSize)
 	end
 
+	if self.sizes then
+		error:assertInvalidate(self.sizes.min >= self.minSize,
+			"Packet size distribution contains packets that are too short. Minimum size for %s is %d",
+			self.proto, self.minSize)
+		error:assertInvalidate(self.sizes.max <= Sizes.maxSize,
+			"Packet size distribution contains packets that are too long. Maximum size is %d",
+			Sizes.maxSize)
+		error:assertInvalidate(Sizes.lengthFields(self.proto),
+			"Packet size distributions are not supported for %s packets.", self.proto)
+	end
+
 	if final then
 		for i,v in pairs(self.depvars) do
 			self.fillTbl[i] = v.dep.getValue(flow, v.tbl)
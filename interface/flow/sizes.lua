@@ -0,0 +1,200 @@
+local Sizes = {}
+Sizes.__index = Sizes
+
+-- largest packet fitting into a default mbuf (2048 bytes data room minus 128 bytes headroom)
+Sizes.maxSize = 1920
+
+-- length of the precomputed sequence when weights cannot be used as is
+local _sequence_length = 4096
+
+-- frame sizes from RFC 6985, reduced by 4 bytes to match pktLength (no CRC)
+local _genome = {
+	a = 60, b = 124, c = 252, d = 508, e = 1020, f = 1276, g = 1514,
+}
+
+local _presets = {
+	simple = { { 60, 7 }, { 590, 4 }, { 1514, 1 } },
+}
+
+-- { offset, base } of 16 bit length fields, assuming an ethernet header without vlan tags
+local _ip4_len, _ip6_len = { 16, 14 }, { 18, 54 }
+local _length_fields = {
+	Eth = {},
+	Ip4 = { _ip4_len }, Ip6 = { _ip6_len },
+	Udp = { _ip4_len, { 38, 34 } }, Udp4 = { _ip4_len, { 38, 34 } },
+	Udp6 = { _ip6_len, { 58, 54 } },
+	Tcp = { _ip4_len }, Tcp4 = { _ip4_len }, Tcp6 = { _ip6_len },
+	Icmp = { _ip4_len }, Icmp4 = { _ip4_len }, Icmp6 = { _ip6_len },
+}
+
+-- rejects nan and infinity
+local function _finite(v)
+	return v == v and v ~= math.huge and v ~= -math.huge
+end
+
+local function _gcd(a, b)
+	while b ~= 0 do
+		a, b = b, a % b
+	end
+	return a
+end
+
+-- turn weights into integer counts, exact if possible
+local function _quantize(weights)
+	local total, exact, divisor = 0, true, 0
+	for _,w in ipairs(weights) do
+		total = total + w
+		exact = exact and w == math.floor(w)
+		if exact then
+			divisor = _gcd(divisor, w)
+		end
+	end
+
+	local counts = {}
+	if exact and total / divisor <= _sequence_length then
+		for i,w in ipairs(weights) do
+			counts[i] = w / divisor
+		end
+		return counts
+	end
+
+	-- largest remainder method
+	local remainders, sum = {}, 0
+	for i,w in ipairs(weights) do
+		local share = w / total * _sequence_length
+		counts[i] = math.floor(share)
+		remainders[i] = { i = i, r = share - counts[i] }
+		sum = sum + counts[i]
+	end
+	table.sort(remainders, function(a, b) return a.r > b.r end)
+	for i = 1, _sequence_length - sum do
+		local idx = remainders[i].i
+		counts[idx] = counts[idx] + 1
+	end
+
+	return counts
+end
+
+--- Create a size distribution from a list of { size, weight } pairs.
+-- Returns nil and an error message on invalid input.
+function Sizes.new(entries)
+	local merged = {}
+	for _,v in ipairs(entries) do
+		local size, weight = v[1], v[2]
+		if type(size) ~= "number" or size ~= math.floor(size) or size <= 0 or size > 0xffff then
+			return nil, ("Invalid packet size %s."):format(tostring(size))
+		elseif type(weight) ~= "number" or weight < 0 or not _finite(weight) then
+			return nil, ("Invalid weight %s for packet size %d."):format(tostring(weight), size)
+		end
+		merged[size] = (merged[size] or 0) + weight
+	end
+
+	local sizes, weights = {}, {}
+	for size in pairs(merged) do
+		if merged[size] > 0 then
+			table.insert(sizes, size)
+		end
+	end
+	table.sort(sizes)
+	local total = 0
+	for i,size in ipairs(sizes) do
+		weights[i] = merged[size]
+		total = total + weights[i]
+	end
+
+	if not _finite(total) then
+		return nil, "Sum of weights is too large."
+	end
+
+	if #sizes == 0 then
+		return nil, "Packet size distribution is empty."
+	end
+
+	local self = { size = {}, count = {}, total = 0, mean = 0 }
+	for i,count in ipairs(_quantize(weights)) do
+		if count > 0 then
+			table.insert(self.size, sizes[i])
+			table.insert(self.count, count)
+			self.total = self.total + count
+			self.mean = self.mean + sizes[i] * count
+		end
+	end
+	self.mean = self.mean / self.total
+	self.min, self.max = self.size[1], self.size[#self.size]
+
+	return setmetatable(self, Sizes)
+end
+
+function Sizes.isSizes(v)
+	return getmetatable(v) == Sizes
+end
+
+--- IMIX preset ('simple') or RFC 6985 genome (e.g. 'aaaaaaaddddg').
+function Sizes.imix(name)
+	name = name or "simple"
+
+	local preset = _presets[name]
+	if preset then
+		return Sizes.new(preset)
+	end
+
+	if not string.find(name, "^[a-g]+$") then
+		return nil, ("Unknown imix %q. Use 'simple' or a RFC 6985 genome using the letters a-g."):format(name)
+	end
+
+	local entries = {}
+	for c in string.gmatch(name, ".") do
+		table.insert(entries, { _genome[c], 1 })
+	end
+	return Sizes.new(entries)
+end
+
+--- Read an empirical size distribution from a file.
+-- Each line contains a packet size and the cumulative probability, lines starting with # are ignored.
+function Sizes.fromCdf(filename)
+	local f, msg = io.open(filename, "r")
+	if not f then
+		return nil, msg
+	end
+
+	local entries, last, n = {}, 0, 0
+	for line in f:lines() do
+		n = n + 1
+		if not string.find(line, "^%s*#") and string.find(line, "%S") then
+			local size, p = string.match(line, "^%s*(%d+)[%s,;]+(%S+)%s*$")
+			p = tonumber(p)
+			if not size or not p or not _finite(p) then
+				f:close()
+				return nil, ("%s:%d: Invalid format. Should be '<size> <cumulative probability>'."):format(filename, n)
+			elseif p < last then
+				f:close()
+				return nil, ("%s:%d: Cumulative probability is decreasing."):format(filename, n)
+			end
+			table.insert(entries, { tonumber(size), p - last })
+			last = p
+		end
+	end
+	f:close()
+
+	return Sizes.new(entries)
+end
+
+--- Length fields of a protocol, nil if unsupported.
+function Sizes.lengthFields(proto)
+	return _length_fields[proto]
+end
+
+function Sizes:__tostring()
+	local result = {}
+	for i,size in ipairs(self.size) do
+		table.insert(result, ("%d (%.1f%%)"):format(size, self.count[i] / self.total * 100))
+	end
+	return table.concat(result, ", ")
+end
+
+--- Native size sequence to be applied to bufArrays, cf. lua/size-distribution.lua.
+function Sizes:newNative(seed)
+	return require("size-distribution"):new(self.size, self.count, seed)
+end
+
+return Sizes
@@ -68,7 +68,7 @@ function master(args) -- luacheck: globals master
 	arpThread.start(devices)
 	deviceStatsThread.start(devices)
 	countThread.start(devices)
-	loadThread.start(devices)
+	loadThread.start(devices, args.output)
 	timestampThread.start(devices, args.output)
 
 	mg.waitForTasks()
@@ -9,6 +9,7 @@ option.description = "Stop sending this flow after a certain amount of data. As"
 	.. " packets sent is the setting of this option multiplied by the nummer of"
 	.. " tx queues requested."
 option.configHelp = "Passing a number instead of a string will interpret the value as megabit."
+	.. " For packet size distributions, the mean packet size is used to convert to packets."
 option.usage = { { "<number><sizeUnit>", "Default use case." } }
 
 local function _parse_limit(lstring, psize)
@@ -36,7 +37,7 @@ end
 function option.parse(self, limit, error)
 	if not limit then return end
 
-	local psize = self:packetSize(true)
+	local psize = self:meanPacketSize(true)
 	local t = type(limit)
 
 	local num, unit
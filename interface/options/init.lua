@@ -1,7 +1,8 @@
 local options = {}
 
 for _,v in ipairs {
-	"rate", "ratePattern", "uniquePayload", "timestamp", "uid", "mode", "dataLimit", "timeLimit"
+	"rate", "ratePattern", "uniquePayload", "timestamp", "uid", "mode", "dataLimit", "timeLimit",
+	"seed", "trace"
 } do
   options[v] =  require("options." .. v)
 end
@@ -11,6 +11,8 @@ local function _parse_rate(rstring, psize)
 		return nil, units.timeError
 	end
 
+	local isPacketRate = false
+
 	if unit == "" then
 		unit = units.size.m --default is mbit/s
 	elseif string.find(unit, "bit$") then
@@ -19,12 +21,13 @@ local function _parse_rate(rstring, psize)
 		unit = units.size[string.sub(unit, 1, -2)] * 8
 	elseif string.find(unit, "p$") then
 		unit = units.size[string.sub(unit, 1, -2)] * psize * 8
+		isPacketRate = true
 	else
 		return nil, units.sizeError
 	end
 
 	unit = unit / 10 ^ 6 -- cbr is in mbit/s
-	return num * unit / time
+	return num * unit / time, isPacketRate
 end
 
 
@@ -33,6 +36,8 @@ local option = {}
 option.description = "Limit the rate of data from this flow. Will automatically"
 	.. " fallback to software ratelimiting if needed."
 option.configHelp = "Passing a number instead of a string will interpret the value as mbit/s."
+	.. " For packet size distributions, packet units use the mean packet size and keep the"
+	.. " packet rate constant, all other units keep the byte rate constant."
 option.usage = {
 	{ "<number><sizeUnit>/<timeUnit>", "Default use case."},
 	{ "<number><sizeUnit>", "Time unit defaults to seconds."},
@@ -45,18 +50,21 @@ function option.parse(self, rate, error)
 
 	local t = type(rate)
 
-	local cbr
+	local cbr, inPackets
 	if t == "number" then
 		cbr = rate
 	elseif t == "string" then
 		local msg
-		cbr, msg = _parse_rate(rate, self:packetSize(true))
-		error:assert(cbr, msg)
+		cbr, msg = _parse_rate(rate, self:meanPacketSize(true))
+		if error:assert(cbr, msg) then
+			inPackets = msg
+		end
 	else
 		error("Invalid argument. String or number expected, got %s.", t)
 	end
 
-	return cbr
+	-- packet rates do not depend on the size of single packets, see Flow:newSizeDistribution
+	return cbr, { rateInPackets = inPackets or false }
 end
 
 return option
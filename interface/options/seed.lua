@@ -0,0 +1,29 @@
+local option = {}
+
+option.description = "Seed used for random decisions of the load generator, i.e. the order of"
+	.. " packet sizes of a size distribution and the inter-departure times of the poisson"
+	.. " rate pattern. Runs using the same seed will use the same schedule. (default = 0)"
+option.configHelp = "Will also accept number values."
+option.usage = {
+	{ "<number>", "Use <number> as seed. Needs to be a non-negative 32 bit integer."},
+}
+
+function option.parse(_, number, error)
+	local t = type(number)
+	if t == "string" then
+		number = error:assert(tonumber(number), "Invalid string. Needs to be convertible to a number.")
+	elseif t ~= "number" and t ~= "nil" then
+		error("Invalid argument. String or number expected, got %s.", t)
+		number = nil
+	end
+
+	-- size distributions are shuffled with a 32 bit seed, larger values would be truncated
+	if number and not error:assert(number >= 0 and number < 2 ^ 32 and number == math.floor(number),
+		"Invalid value. Needs to be a non-negative 32 bit integer.") then
+		number = nil
+	end
+
+	return number or 0
+end
+
+return option
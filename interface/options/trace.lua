@@ -0,0 +1,19 @@
+local units = require "units"
+
+local option = {}
+
+option.description = "Record the target and actual departure time of each packet sent by the"
+	.. " software rate limiter. Forces software rate limiting when a rate is set."
+	.. " The trace is written to '<output>/<flow>_<uid>-<dev>_<queue>.trace' and can be"
+	.. " analyzed using examples/rate-limiter-trace.lua. (default = false)"
+option.configHelp = "Will also accept boolean values."
+option.usage = {
+	{ "<boolean>", "Default use case."},
+	{ nil, "Set option to true."},
+}
+
+function option.parse(_, bool, error)
+	return units.parseBool(bool, false, error)
+end
+
+return option
@@ -12,7 +12,8 @@ option.usage = {
 }
 
 function option.parse(self, bool, error)
-	local len = self:packetSize()
+	local sizes = self.packet.sizes
+	local len = sizes and sizes.min or self:packetSize()
 
 	local hasPayload = self.packet.hasPayload
 	local fillsEthFrame = len >= 60
@@ -0,0 +1,152 @@
+local memory = require "memory"
+local log    = require "log"
+
+local devmgr = require "devmgr"
+
+-- packets per bufArray
+local batchSize = 64
+-- traffic buffered in the rate limiter ring, in seconds
+local ringTime = 0.001
+local minRing, maxRing = 2 * batchSize, 2 ^ 16
+-- static flows below this packet rate may share a mempool with flows on the same socket and of the same size class
+local sharedRate = 100000
+-- mbuf header and mempool object header
+local mbufOverhead = 192
+-- default mbuf data room incl. headroom, see libmoon memory.createMemPool
+local defaultBufSize = 2048
+
+local function nextPow2(n)
+	local r = 1
+	while r < n do r = r * 2 end
+	return r
+end
+
+-- mempools are most efficient with 2^n - 1 entries
+local function poolSize(n)
+	return nextPow2(n + 1) - 1
+end
+
+local function bufSize(flow)
+	-- CRC and headroom, round to cache lines
+	local size = math.ceil((flow:packetSize(true) + 128) / 64) * 64
+	return math.min(math.max(size, 256), defaultBufSize)
+end
+
+-- flows only share mempools with flows of similar packet sizes, classes are powers of two
+local function sizeClass(size)
+	return math.min(nextPow2(size), defaultBufSize)
+end
+
+local function bytes(mbufs, size)
+	return mbufs * (size + mbufOverhead)
+end
+
+local poolmgr = {}
+poolmgr.__index = poolmgr
+
+--- Packet rate of a flow, line rate if no rate is set.
+function poolmgr.packetRate(flow, linkSpeed)
+	local rate = flow:option "rate" or linkSpeed
+	-- 20 bytes preamble and inter-frame gap when sending at line rate
+	local psize = flow:meanPacketSize(true) + (flow:option "rate" and 0 or 20)
+	return rate * 10 ^ 6 / (psize * 8)
+end
+
+--- Size of the ring between load thread and software rate limiter.
+function poolmgr.ringSize(flow, linkSpeed)
+	local pps = poolmgr.packetRate(flow, linkSpeed)
+	-- poisson traffic is drained in bursts, allow for more buffering
+	local burst = flow:option "ratePattern" == "poisson" and 4 or 1
+	return math.min(math.max(nextPow2(pps * ringTime * burst), minRing), maxRing)
+end
+
+--- Plan the mempool of a flow.
+-- @param ring size of the rate limiter ring, nil if no software rate limiter is used
+function poolmgr:add(flow, txQueue, linkSpeed, ring)
+	local pps = poolmgr.packetRate(flow, linkSpeed)
+	local plan = {
+		name = flow.proto.name, uid = flow:option "uid",
+		dev = txQueue.id, qid = txQueue.qid,
+		pps = pps, ring = ring, bufSize = bufSize(flow),
+		-- all mbufs in the ring, the tx descriptors and the bufArray may be in use at once
+		need = (ring or 0) + devmgr.txDescs + 2 * batchSize,
+	}
+
+	plan.mbufs = poolSize(plan.need)
+
+	-- candidates for a shared mempool, decided in createArenas
+	if flow:option "rate" and not flow.isDynamic and pps < sharedRate then
+		local socket, class = txQueue.dev:getSocket(), sizeClass(plan.bufSize)
+		local key = ("%d-%d"):format(socket, class)
+		local arena = self.arenas[key] or { socket = socket, need = 0, bufSize = 0, dedicated = 0, plans = {} }
+		arena.need = arena.need + plan.need
+		arena.bufSize = math.max(arena.bufSize, plan.bufSize)
+		arena.dedicated = arena.dedicated + bytes(plan.mbufs, plan.bufSize)
+		table.insert(arena.plans, plan)
+		self.arenas[key] = arena
+	end
+
+	table.insert(self.plans, plan)
+	return plan
+end
+
+--- Create the shared mempools, has to be called from the master task after all flows were added.
+-- Flows only share a mempool if it uses less memory than their dedicated mempools, as shared flows
+-- cannot use the native send engine.
+function poolmgr:createArenas()
+	for key, arena in pairs(self.arenas) do
+		-- all flows may fill their rings and tx queues at the same time
+		arena.mbufs = poolSize(arena.need)
+		if bytes(arena.mbufs, arena.bufSize) < arena.dedicated then
+			arena.pool = memory.createMemPool{ n = arena.mbufs, socket = arena.socket, bufSize = arena.bufSize }
+			for _,plan in ipairs(arena.plans) do
+				plan.shared = true
+				plan.socket = arena.socket
+				plan.pool = arena.pool
+			end
+		else
+			self.arenas[key] = nil
+		end
+	end
+end
+
+--- Log hugepage usage and headroom of all flows.
+function poolmgr:report()
+	local total = 0
+	for _,plan in ipairs(self.plans) do
+		local pool, buffered
+		if plan.shared then
+			pool = ("shared (socket %d, %d B), needs %d mbufs"):format(plan.socket, plan.bufSize, plan.need)
+		else
+			local mem = bytes(plan.mbufs, plan.bufSize)
+			pool = ("%d x %d B, %.1f MiB, headroom %d mbufs"):format(
+				plan.mbufs, plan.bufSize, mem / 2 ^ 20, plan.mbufs - plan.need)
+			total = total + mem
+		end
+		if plan.ring then
+			total = total + plan.ring * 8
+			-- time the ring can bridge if the load thread is late
+			buffered = ("ring %d = %.2f ms"):format(plan.ring, plan.ring / plan.pps * 1000)
+		else
+			buffered = "no ring"
+		end
+		log:info("Flow %s (%#x) dev=%d queue=%d: %.3f Mpps, mempool %s, %s",
+			plan.name, plan.uid, plan.dev, plan.qid, plan.pps / 10 ^ 6, pool, buffered)
+	end
+	for _, arena in pairs(self.arenas) do
+		local mem = bytes(arena.mbufs, arena.bufSize)
+		total = total + mem
+		log:info("Shared mempool socket %d: %d flows, %d x %d B, %.1f MiB (dedicated %.1f MiB), headroom %d mbufs",
+			arena.socket, #arena.plans, arena.mbufs, arena.bufSize, mem / 2 ^ 20,
+			arena.dedicated / 2 ^ 20, arena.mbufs - arena.need)
+	end
+	log:info("Total hugepage memory for packet buffers: %.1f MiB", total / 2 ^ 20)
+end
+
+local mod = {}
+
+function mod.newPoolmgr()
+	return setmetatable({ plans = {}, arenas = {} }, poolmgr)
+end
+
+return mod
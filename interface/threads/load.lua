@@ -1,14 +1,30 @@
+local ffi     = require "ffi"
 local dpdkc   = require "dpdkc"
 local limiter = require "software-ratecontrol"
+local engine  = require "send-engine"
 local memory  = require "memory"
 local mg      = require "moongen"
 local timer   = require "timer"
 local stats   = require "stats"
+local log     = require "log"
 
 local Flow = require "flow"
+local poolmgr = require "poolmgr"
 
 local thread = { flows = {} }
 
+-- checksum offloading per protocol, used by the native send engine and the lua loop
+local _offload_modes = {
+	Ip4 = "ip4", Tcp = "ip4", Tcp4 = "ip4", Icmp = "ip4", Icmp4 = "ip4",
+	Udp = "udp4", Udp4 = "udp4", Udp6 = "udp6",
+}
+
+local _offload_lua = {
+	ip4 = function(bufs) bufs:offloadIPChecksums() end,
+	udp4 = function(bufs) bufs:offloadUdpChecksums() end,
+	udp6 = function(bufs) bufs:offloadUdpChecksums(false) end,
+}
+
 function thread.prepare(flows, devices)
 	for _,flow in ipairs(flows) do
 		for _,tx in ipairs(flow:property "tx") do
@@ -18,35 +34,80 @@ function thread.prepare(flows, devices)
 	end
 end
 
-function thread.start(devices)
+function thread.start(devices, directory)
+	local pools, tasks = poolmgr.newPoolmgr(), {}
+
 	for _,flow in ipairs(thread.flows) do
-		local txQueue = devices:txQueue(flow:property "tx_dev")
+		local queue = devices:txQueue(flow:property "tx_dev")
+		local speed = queue.dev:getLinkStatus().speed
+		local txQueue, linkSpeed = queue, nil
+
+		local limiterArgs = { seed = flow:option "seed", ringSize = poolmgr.ringSize(flow, speed) }
+		if flow:option "trace" then
+			limiterArgs.trace = string.format("%s/%s_%d-%d_%d.trace", directory,
+				flow.proto.name, flow:option "uid", txQueue.id, txQueue.qid)
+			if not flow:option "rate" then
+				log:warn("Flow %s: trace is only recorded when a rate is set.", flow.proto.name)
+			end
+		end
 
 		-- setup rate limit
 		if flow:option "rate" then
 			if flow:option "ratePattern" == "cbr" then
-				local rc = dpdkc.rte_eth_set_queue_rate_limit(txQueue.id, txQueue.qid, flow:option "rate")
+				local rc = -1
+				if not limiterArgs.trace then
+					rc = dpdkc.rte_eth_set_queue_rate_limit(txQueue.id, txQueue.qid, flow:option "rate")
+				end
 				if rc ~= 0 then -- fallback to software ratelimiting
-					txQueue = limiter:new(txQueue, "cbr", flow:getDelay())
+					if flow.packet.sizes and not flow:option "rateInPackets" then
+						-- delay depends on the size of each packet
+						linkSpeed = speed
+						txQueue = limiter:new(txQueue, "custom", nil, limiterArgs)
+					else
+						txQueue = limiter:new(txQueue, "cbr", flow:getDelay(), limiterArgs)
+					end
 				end
 			elseif flow.results.ratePattern == "poisson" then
-				txQueue = limiter:new(txQueue, "poisson", flow:getDelay())
+				txQueue = limiter:new(txQueue, "poisson", flow:getDelay(), limiterArgs)
 			end
 		end
 
-		mg.startTask("__INTERFACE_LOAD", flow, txQueue)
+		local ring = txQueue ~= queue and limiterArgs.ringSize or nil
+		local plan = pools:add(flow, queue, speed, ring)
+		table.insert(tasks, { flow = flow, txQueue = txQueue, linkSpeed = linkSpeed, plan = plan })
 	end
-end
 
-local function loadThread(flow, sendQueue)
-	flow = Flow.restore(flow)
+	pools:createArenas()
+	pools:report()
 
-	local counter = stats:newPktTxCounter(
-		("Flow: dev=%d uid=%#x"):format(flow:property "tx_dev", flow:option "uid")
-	)
+	for _,v in ipairs(tasks) do
+		mg.startTask("__INTERFACE_LOAD", v.flow, v.txQueue, v.linkSpeed, v.plan)
+	end
+end
+
+-- static flows are sent by a native loop, lua only updates the counter
+local function sendNative(flow, mempool, sendQueue, sizes, counter)
+	local sender = engine:new{
+		pktLength = flow:packetSize(), sizes = sizes,
+		packets = flow:option "dataLimit", time = flow:option "timeLimit",
+		offload = _offload_modes[flow.packet.proto],
+	}
+
+	local packets, bytes = 0, 0
+	repeat
+		local finished = sender:run(mempool, sendQueue)
+		local p, b = sender:getStats()
+		-- engine counts bytes without CRC
+		counter:update(p - packets, b - bytes + (p - packets) * 4)
+		packets, bytes = p, b
+	until finished
+end
 
-	local mempool = memory.createMemPool(function(buf) flow:fillBuf(buf) end)
+local function sendLua(flow, mempool, sendQueue, sizes, counter, shared)
 	local bufs = mempool:bufArray()
+	-- largest packet of a size distribution
+	local maxSize = flow:packetSize()
+	local offload = _offload_lua[_offload_modes[flow.packet.proto]]
 
 	-- dataLimit in packets, timeLimit in seconds
 	local data, runtime = flow:option "dataLimit", nil
@@ -54,16 +115,30 @@ local function loadThread(flow, sendQueue)
 		runtime = timer:new(flow:option "timeLimit")
 	end
 
-	flow:property("counter"):inc()
-
 	while mg.running() and (not runtime or runtime:running()) do
 		bufs:alloc(flow:packetSize())
 
-		if flow.isDynamic then
+		if shared then
 			for _, buf in ipairs(bufs) do
+				-- clear leftovers of other flows, e.g. their uid at the end of the payload
+				ffi.fill(buf:getBytes(), maxSize)
+				flow:fillBuf(buf)
+			end
+		end
+
+		if sizes then
+			sizes:apply(bufs)
+		end
+
+		for _, buf in ipairs(bufs) do
+			if flow.isDynamic then
 				flow:updateBuf(buf)
-				counter:countPacket(buf)
 			end
+			counter:countPacket(buf)
+		end
+
+		if offload then
+			offload(bufs)
 		end
 
 		if data then
@@ -74,11 +149,38 @@ local function loadThread(flow, sendQueue)
 			end
 		end
 
-		bufs:offloadUdpChecksums()
 		sendQueue:send(bufs)
 
 		counter:update()
 	end
+end
+
+local function loadThread(flow, sendQueue, linkSpeed, plan)
+	flow = Flow.restore(flow)
+
+	local name = ("Flow: dev=%d uid=%#x"):format(flow:property "tx_dev", flow:option "uid")
+
+	-- shared mempools hold packets of other flows, buffers are filled on each alloc
+	local mempool, shared = plan.pool, plan.pool ~= nil
+	if not shared then
+		mempool = memory.createMemPool{
+			n = plan.mbufs, bufSize = plan.bufSize,
+			func = function(buf) flow:fillBuf(buf) end
+		}
+	end
+	local sizes = flow:newSizeDistribution(linkSpeed)
+
+	flow:property("counter"):inc()
+
+	local counter
+	if flow.isDynamic or shared then
+		counter = stats:newPktTxCounter(name)
+		sendLua(flow, mempool, sendQueue, sizes, counter, shared)
+	else
+		-- packets never pass through lua, the engine reports its totals instead
+		counter = stats:newManualTxCounter(name)
+		sendNative(flow, mempool, sendQueue, sizes, counter)
+	end
 
 	flow:property("counter"):dec()
 
@@ -0,0 +1,88 @@
+local ffi     = require "ffi"
+local memory  = require "memory"
+local log     = require "log"
+
+local C = ffi.C
+
+ffi.cdef[[
+	struct size_distribution;
+
+	struct send_engine_control {
+		uint64_t packet_limit;
+		double time_limit;
+		uint64_t end_time;
+		uint16_t pkt_len;
+		uint8_t offload;
+		uint8_t stop;
+		uint64_t packets;
+		uint64_t bytes;
+	};
+
+	bool mg_send_engine_run(struct mempool* pool, uint8_t device, uint16_t queue, struct rte_ring* ring, struct size_distribution* sizes, struct send_engine_control* ctl, uint32_t slice_ms);
+]]
+
+local offloadModes = {
+	none = 0, ip4 = 1, udp4 = 2, udp6 = 3,
+}
+
+local mod = {}
+local sendEngine = {}
+mod.sendEngine = sendEngine
+
+sendEngine.__index = sendEngine
+
+--- Run the engine for about one time slice.
+-- @param mempool mempool holding the packet template, all buffers are sent unchanged besides length and offloading
+-- @param queue tx queue or software rate limiter
+-- @param slice optional, time in milliseconds after which control is returned to the caller, defaults to 100
+-- @return true if the engine is finished, i.e., a limit was reached, it was stopped or libmoon is shutting down
+function sendEngine:run(mempool, queue, slice)
+	if queue.ring then -- software rate limiter
+		return C.mg_send_engine_run(mempool, 0, 0, queue.ring, self.sizes, self.ctl, slice or 100)
+	end
+	queue.used = true
+	return C.mg_send_engine_run(mempool, queue.id, queue.qid, nil, self.sizes, self.ctl, slice or 100)
+end
+
+-- stop the engine, it will return from the current or next call to run
+function sendEngine:stop()
+	self.ctl.stop = 1
+	memory.fence()
+end
+
+--- Get the number of packets and bytes (without CRC) sent so far.
+function sendEngine:getStats()
+	return tonumber(self.ctl.packets), tonumber(self.ctl.bytes)
+end
+
+--- Create a native send loop for static packets, i.e., all fields besides the length are set by the mempool.
+-- Can be used by the sending task instead of a loop of bufs:alloc(), queue:send(bufs).
+-- @param args table with the following fields
+--   - pktLength: packet size, ignored if sizes is set
+--   - sizes: optional, size distribution, see size-distribution.lua
+--   - packets: optional, stop after this number of packets
+--   - time: optional, stop after this time in seconds, starting with the first call to run
+--   - offload: optional, checksum offloading, either "none", "ip4", "udp4", or "udp6". Defaults to none.
+function mod:new(args)
+	local offload = offloadModes[args.offload or "none"]
+	if not offload then
+		log:fatal("Unsupported offload mode " .. args.offload)
+	end
+	local ctl = memory.alloc("struct send_engine_control*", ffi.sizeof("struct send_engine_control"))
+	ctl.packet_limit = args.packets or 0
+	ctl.time_limit = args.time or 0
+	ctl.end_time = 0
+	ctl.pkt_len = args.pktLength or 0
+	ctl.offload = offload
+	ctl.stop = 0
+	ctl.packets = 0
+	ctl.bytes = 0
+	return setmetatable({
+		ctl = ctl,
+		sizes = args.sizes and args.sizes.dist,
+		-- keep the size distribution alive while in use
+		sizeDist = args.sizes,
+	}, sendEngine)
+end
+
+return mod
@@ -0,0 +1,73 @@
+local ffi     = require "ffi"
+local log     = require "log"
+
+local C = ffi.C
+
+ffi.cdef[[
+	struct size_distribution { };
+
+	struct size_distribution* mg_size_dist_create(const uint16_t* sizes, const uint32_t* counts, uint32_t n, uint32_t seed);
+	void mg_size_dist_delete(struct size_distribution* dist);
+	bool mg_size_dist_add_length_field(struct size_distribution* dist, uint16_t offset, uint16_t base);
+	void mg_size_dist_set_uid(struct size_distribution* dist, uint32_t uid);
+	void mg_size_dist_set_gap(struct size_distribution* dist, double scale);
+	uint64_t mg_size_dist_apply(struct size_distribution* dist, struct rte_mbuf** bufs, uint32_t n);
+]]
+
+local mod = {}
+local sizeDist = {}
+mod.sizeDist = sizeDist
+
+sizeDist.__index = sizeDist
+
+--- Set packet lengths of a whole bufArray from the precomputed size sequence.
+-- Also updates all registered length fields, the uid (if set) and the delay used by the software rate limiter.
+-- @param bufs the bufArray, buffers need to be allocated with the largest size of the distribution
+-- @param n optional, number of packets to update (defaults to full bufs)
+-- @return number of bytes (without CRC) of the updated packets
+function sizeDist:apply(bufs, n)
+	return tonumber(C.mg_size_dist_apply(self.dist, bufs.array, n or bufs.size))
+end
+
+--- Register a 16 bit big endian header field that is set to the packet length minus base.
+-- @param offset byte offset of the field from the start of the packet
+-- @param base bytes not covered by the length field (e.g. 14 for the total length of an ip4 packet)
+function sizeDist:addLengthField(offset, base)
+	if not C.mg_size_dist_add_length_field(self.dist, offset, base) then
+		log:fatal("Too many length fields for packet size distribution.")
+	end
+end
+
+--- Write the uid to the last four bytes of each packet, see uniquePayload.
+function sizeDist:setUid(uid)
+	C.mg_size_dist_set_uid(self.dist, uid)
+end
+
+--- Set the delay (cf. pkt:setDelay) of each packet so that the software rate limiter
+--- holds a byte rate across the mix.
+-- @param linkSpeed link speed in Mbit/s
+-- @param rate target rate in Mbit/s (including CRC)
+function sizeDist:setRate(linkSpeed, rate)
+	C.mg_size_dist_set_gap(self.dist, linkSpeed / rate)
+end
+
+--- Create a new packet size distribution.
+-- The sizes are expanded into a sequence containing each size count times and shuffled.
+-- @param sizes list of packet sizes (without CRC)
+-- @param counts list of occurrences of the respective size in the sequence
+-- @param seed optional, 32 bit seed for the shuffle. Defaults to a fixed value, i.e. the same sequence on each run.
+function mod:new(sizes, counts, seed)
+	local n = #sizes
+	local dist = C.mg_size_dist_create(
+		ffi.new("uint16_t[?]", n, sizes), ffi.new("uint32_t[?]", n, counts), n, seed or 0
+	)
+	if dist == nil then
+		log:fatal("Empty packet size distribution.")
+	end
+
+	return setmetatable({
+		dist = ffi.gc(dist, C.mg_size_dist_delete)
+	}, sizeDist)
+end
+
+return mod
@@ -13,14 +13,21 @@ ffi.cdef[[
 		void* bufs[0];
 	};
 
+	struct limiter_trace { };
+
 	struct limiter_control {
 		uint64_t count;
 		uint8_t stop;
+		struct limiter_trace* trace;
+		uint64_t seed;
 	};
 
 	void mg_rate_limiter_main_loop(struct rte_ring* ring, uint8_t device, uint16_t queue, uint32_t link_speed, struct limiter_control* ctl);
 	void mg_rate_limiter_cbr_main_loop(struct rte_ring* ring, uint8_t device, uint16_t queue, uint32_t target, struct limiter_control* ctl);
 	void mg_rate_limiter_poisson_main_loop(struct rte_ring* ring, uint8_t device, uint16_t queue, uint32_t target, uint32_t link_speed, struct limiter_control* ctl);
+
+	struct limiter_trace* mg_rate_limiter_trace_create(uint32_t size);
+	bool mg_rate_limiter_trace_write(struct limiter_trace* trace, uint64_t seed, const char* path);
 ]]
 
 local mod = {}
@@ -62,12 +69,18 @@ end
 -- @param queue the wrapped tx queue
 -- @param mode optional, either "cbr", "poisson", or "custom". Defaults to custom.
 -- @param delay optional, inter-departure time in nanoseconds for cbr, 1/lambda (average) for poisson
-function mod:new(queue, mode, delay)
+-- @param args optional table with the following fields
+--   - trace: file to write the target and actual departure time of each packet to, see examples/rate-limiter-trace.lua
+--   - traceSize: number of entries buffered until the trace is written to the file, defaults to 2^20
+--   - seed: seed for the random number generator of the poisson mode, the same seed results in the same schedule
+--   - ringSize: number of packets buffered between the sending task and the rate limiter, uses the default of pipe otherwise
+function mod:new(queue, mode, delay, args)
 	mode = mode or "custom"
+	args = args or {}
 	if mode ~= "poisson" and mode ~= "cbr" and mode ~= "custom" then
 		log:fatal("Unsupported mode " .. mode)
 	end
-	local ring = pipe:newPacketRing()
+	local ring = pipe:newPacketRing(args.ringSize)
 	local obj = setmetatable({
 		ring = ring.ring,
 		mode = mode,
@@ -75,6 +88,15 @@ function mod:new(queue, mode, delay)
 		queue = queue,
 		ctl = memory.alloc("struct limiter_control*", ffi.sizeof("struct limiter_control"))
 	}, rateLimiter)
+	obj.ctl.trace = nil
+	obj.ctl.seed = args.seed or 0
+	if args.trace then
+		obj.ctl.trace = C.mg_rate_limiter_trace_create(args.traceSize or 2^20)
+		if obj.ctl.trace == nil then
+			log:fatal("Could not allocate rate limiter trace.")
+		end
+		mg.startTask("__MG_RATE_LIMITER_TRACE", obj.ctl, args.trace)
+	end
 	mg.startTask("__MG_RATE_LIMITER_MAIN", obj.ring, queue.id, queue.qid, mode, delay, queue.dev:getLinkStatus().speed, obj.ctl)
 	return obj
 end
@@ -90,4 +112,11 @@ function __MG_RATE_LIMITER_MAIN(ring, devId, qid, mode, delay, speed, ctl)
 	end
 end
 
+-- the trace is freed by the writer after the rate limiter finished
+function __MG_RATE_LIMITER_TRACE(ctl, file)
+	if not C.mg_rate_limiter_trace_write(ctl.trace, ctl.seed, file) then
+		log:error("Could not write rate limiter trace to %s.", file)
+	end
+end
+
 return mod
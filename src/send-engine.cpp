@@ -0,0 +1,155 @@
+#include <rte_config.h>
+#include <rte_common.h>
+#include <rte_ring.h>
+#include <rte_mbuf.h>
+#include <stdint.h>
+#include <rte_ethdev.h>
+#include <rte_mempool.h>
+#include <rte_ip.h>
+#include <rte_udp.h>
+#include <rte_cycles.h>
+#include <atomic>
+#include <algorithm>
+#include "ring.h"
+#include "lifecycle.hpp"
+#include "size-distribution.hpp"
+
+namespace send_engine {
+	constexpr int batch_size = 64;
+	constexpr uint16_t eth_len = 14;
+
+	enum offload_mode : uint8_t {
+		offload_none = 0,
+		offload_ip4 = 1,
+		offload_udp4 = 2,
+		offload_udp6 = 3,
+	};
+
+	struct control {
+		// configuration, 0 means no limit
+		uint64_t packet_limit;
+		double time_limit;
+		uint64_t end_time;
+		uint16_t pkt_len;
+		uint8_t offload;
+		std::atomic<uint8_t> stop;
+		// statistics, only written by the engine
+		std::atomic<uint64_t> packets;
+		std::atomic<uint64_t> bytes;
+
+		inline bool running() {
+			return libmoon::is_running(0) && !stop.load(std::memory_order_relaxed);
+		};
+	};
+
+	static inline void offload(struct rte_mbuf* buf, uint8_t mode) {
+		if (mode == offload_udp6) {
+			struct ipv6_hdr* ip = rte_pktmbuf_mtod_offset(buf, struct ipv6_hdr*, eth_len);
+			struct udp_hdr* udp = rte_pktmbuf_mtod_offset(buf, struct udp_hdr*, eth_len + sizeof(struct ipv6_hdr));
+			buf->ol_flags |= PKT_TX_IPV6 | PKT_TX_UDP_CKSUM;
+			buf->l2_len = eth_len;
+			buf->l3_len = sizeof(struct ipv6_hdr);
+			udp->dgram_cksum = rte_ipv6_phdr_cksum(ip, buf->ol_flags);
+			return;
+		}
+		struct ipv4_hdr* ip = rte_pktmbuf_mtod_offset(buf, struct ipv4_hdr*, eth_len);
+		buf->ol_flags |= PKT_TX_IPV4 | PKT_TX_IP_CKSUM;
+		buf->l2_len = eth_len;
+		buf->l3_len = sizeof(struct ipv4_hdr);
+		ip->hdr_checksum = 0;
+		if (mode == offload_udp4) {
+			struct udp_hdr* udp = rte_pktmbuf_mtod_offset(buf, struct udp_hdr*, eth_len + sizeof(struct ipv4_hdr));
+			buf->ol_flags |= PKT_TX_UDP_CKSUM;
+			udp->dgram_cksum = rte_ipv4_phdr_cksum(ip, buf->ol_flags);
+		}
+	}
+
+	/*
+	 * Send all packets to the tx queue or, if ring is set, to the ring of a software rate limiter
+	 * Returns false if the engine was stopped before all packets were sent, unsent packets are freed.
+	 */
+	static inline bool send_all(struct rte_ring* ring, uint8_t device, uint16_t queue, struct rte_mbuf** bufs, uint32_t n, control* ctl) {
+		uint32_t sent = 0;
+		while (sent < n) {
+			if (ring) {
+				sent += ring_enqueue(ring, reinterpret_cast<void**>(bufs + sent), n - sent);
+			} else {
+				sent += rte_eth_tx_burst(device, queue, bufs + sent, n - sent);
+			}
+			if (sent < n && !ctl->running()) {
+				for (uint32_t i = sent; i < n; i++) {
+					rte_pktmbuf_free(bufs[i]);
+				}
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/*
+	 * Allocate, prepare and send packets from a mempool holding a static packet template
+	 * Returns after roughly slice_ms to allow the caller to update statistics,
+	 * the return value indicates whether the engine is finished.
+	 */
+	static bool run(struct rte_mempool* pool, uint8_t device, uint16_t queue, struct rte_ring* ring,
+			size_distribution::distribution* sizes, control* ctl, uint32_t slice_ms) {
+		uint64_t tsc_hz = rte_get_tsc_hz();
+		uint64_t cur = rte_get_tsc_cycles();
+		if (ctl->time_limit > 0 && !ctl->end_time) {
+			ctl->end_time = cur + (uint64_t) (ctl->time_limit * tsc_hz);
+		}
+		uint64_t slice_end = cur + slice_ms * tsc_hz / 1000;
+		uint64_t packets = ctl->packets.load(std::memory_order_relaxed);
+		uint64_t bytes = ctl->bytes.load(std::memory_order_relaxed);
+		struct rte_mbuf* bufs[batch_size];
+		while (ctl->running()) {
+			cur = rte_get_tsc_cycles();
+			if (ctl->end_time && cur >= ctl->end_time) {
+				return true;
+			}
+			if (cur >= slice_end) {
+				return false;
+			}
+			uint32_t n = batch_size;
+			if (ctl->packet_limit) {
+				if (packets >= ctl->packet_limit) {
+					return true;
+				}
+				n = std::min<uint64_t>(n, ctl->packet_limit - packets);
+			}
+			// mempool is empty while packets are still queued, try again
+			if (rte_pktmbuf_alloc_bulk(pool, bufs, n) != 0) {
+				continue;
+			}
+			if (sizes) {
+				bytes += size_distribution::apply(sizes, bufs, n);
+			} else {
+				for (uint32_t i = 0; i < n; i++) {
+					bufs[i]->data_len = ctl->pkt_len;
+					bufs[i]->pkt_len = ctl->pkt_len;
+				}
+				bytes += n * ctl->pkt_len;
+			}
+			if (ctl->offload != offload_none) {
+				for (uint32_t i = 0; i < n; i++) {
+					offload(bufs[i], ctl->offload);
+				}
+			}
+			if (!send_all(ring, device, queue, bufs, n, ctl)) {
+				return true;
+			}
+			packets += n;
+			ctl->packets.store(packets, std::memory_order_relaxed);
+			ctl->bytes.store(bytes, std::memory_order_relaxed);
+		}
+		return true;
+	}
+}
+
+extern "C" {
+	bool mg_send_engine_run(struct rte_mempool* pool, uint8_t device, uint16_t queue, struct rte_ring* ring,
+			size_distribution::distribution* sizes, send_engine::control* ctl, uint32_t slice_ms) {
+		return send_engine::run(pool, device, queue, ring, sizes, ctl, slice_ms);
+	}
+}
+
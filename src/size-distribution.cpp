@@ -0,0 +1,72 @@
+#include <stdint.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "size-distribution.hpp"
+
+namespace size_distribution {
+	/*
+	 * Expands the (size, count) pairs into a sequence and shuffles it, so that sizes are interleaved
+	 * while the exact ratios hold for every full pass over the sequence.
+	 */
+	static distribution* create(const uint16_t* sizes, const uint32_t* counts, uint32_t n, uint32_t seed) {
+		distribution* dist = new distribution;
+		for (uint32_t i = 0; i < n; i++) {
+			for (uint32_t j = 0; j < counts[i]; j++) {
+				dist->slots.push_back({sizes[i], 0});
+			}
+		}
+		if (dist->slots.empty()) {
+			delete dist;
+			return nullptr;
+		}
+		std::mt19937 rand(seed);
+		std::shuffle(dist->slots.begin(), dist->slots.end(), rand);
+		return dist;
+	}
+
+	/*
+	 * Sets the inter-departure time (in bytes at link speed) for each slot as used by the software rate limiter
+	 * scale: link speed / target rate
+	 */
+	static void set_gap(distribution* dist, double scale) {
+		for (auto& s : dist->slots) {
+			s.gap = (uint64_t) ((s.size + crc_size) * scale);
+		}
+	}
+}
+
+extern "C" {
+	size_distribution::distribution* mg_size_dist_create(const uint16_t* sizes, const uint32_t* counts, uint32_t n, uint32_t seed) {
+		return size_distribution::create(sizes, counts, n, seed);
+	}
+
+	void mg_size_dist_delete(size_distribution::distribution* dist) {
+		delete dist;
+	}
+
+	bool mg_size_dist_add_length_field(size_distribution::distribution* dist, uint16_t offset, uint16_t base) {
+		if (dist->num_fields >= size_distribution::max_length_fields) {
+			return false;
+		}
+		dist->fields[dist->num_fields++] = {offset, base};
+		return true;
+	}
+
+	void mg_size_dist_set_uid(size_distribution::distribution* dist, uint32_t uid) {
+		dist->set_uid = true;
+		dist->uid[0] = uid >> 24;
+		dist->uid[1] = uid >> 16;
+		dist->uid[2] = uid >> 8;
+		dist->uid[3] = uid;
+	}
+
+	void mg_size_dist_set_gap(size_distribution::distribution* dist, double scale) {
+		size_distribution::set_gap(dist, scale);
+	}
+
+	uint64_t mg_size_dist_apply(size_distribution::distribution* dist, struct rte_mbuf** bufs, uint32_t n) {
+		return size_distribution::apply(dist, bufs, n);
+	}
+}
+
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <rte_config.h>
+#include <rte_common.h>
+#include <rte_mbuf.h>
+#include <rte_byteorder.h>
+#include <stdint.h>
+#include <vector>
+
+namespace size_distribution {
+	constexpr int max_length_fields = 4;
+	// bytes per frame not covered by pkt_len (CRC) but relevant for the wire rate
+	constexpr uint32_t crc_size = 4;
+
+	struct slot {
+		uint16_t size;
+		uint64_t gap;
+	};
+
+	// 16 bit big endian length field in a header, value is pkt_len - base
+	struct length_field {
+		uint16_t offset;
+		uint16_t base;
+	};
+
+	struct distribution {
+		std::vector<slot> slots;
+		uint32_t pos = 0;
+		length_field fields[max_length_fields];
+		int num_fields = 0;
+		bool set_uid = false;
+		uint8_t uid[4];
+	};
+
+	static inline uint64_t apply(distribution* dist, struct rte_mbuf** bufs, uint32_t n) {
+		uint64_t bytes = 0;
+		uint32_t pos = dist->pos;
+		uint32_t num_slots = dist->slots.size();
+		for (uint32_t i = 0; i < n; i++) {
+			const slot& s = dist->slots[pos];
+			if (++pos == num_slots) {
+				pos = 0;
+			}
+			struct rte_mbuf* buf = bufs[i];
+			uint8_t* data = rte_pktmbuf_mtod(buf, uint8_t*);
+			buf->data_len = s.size;
+			buf->pkt_len = s.size;
+			buf->udata64 = s.gap;
+			for (int f = 0; f < dist->num_fields; f++) {
+				*reinterpret_cast<uint16_t*>(data + dist->fields[f].offset) = rte_cpu_to_be_16(s.size - dist->fields[f].base);
+			}
+			if (dist->set_uid) {
+				data[s.size - 1] = dist->uid[0];
+				data[s.size - 2] = dist->uid[1];
+				data[s.size - 3] = dist->uid[2];
+				data[s.size - 4] = dist->uid[3];
+			}
+			bytes += s.size;
+		}
+		dist->pos = pos;
+		return bytes;
+	}
+}
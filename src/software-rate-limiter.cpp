@@ -5,11 +5,15 @@
 #include <stdint.h>
 #include <rte_ethdev.h> 
 #include <rte_mempool.h>
+#include <rte_malloc.h>
 #include <rte_ether.h>
 #include <rte_cycles.h>
 #include <random>
 #include <atomic>
+#include <algorithm>
 #include <iostream>
+#include <cstdio>
+#include <cstring>
 #include <unistd.h>
 #include "ring.h"
 #include "lifecycle.hpp"
@@ -27,9 +31,61 @@
 namespace rate_limiter {
 	constexpr int batch_size = 64;
 
+	// departure of a single packet, times in TSC cycles
+	struct trace_entry {
+		uint64_t target;
+		int32_t error; // actual - target, saturated, actual is taken after rte_eth_tx_burst accepted the packet
+		uint32_t retries; // calls to rte_eth_tx_burst that did not accept the packet
+	};
+
+	/*
+	 * Single producer (rate limiter), single consumer (trace writer) ring of departures
+	 * The pacer never waits for the writer, entries are dropped if the ring is full.
+	 */
+	struct limiter_trace {
+		// written by the rate limiter
+		alignas(64) std::atomic<uint64_t> head;
+		uint64_t cached_tail;
+		uint64_t dropped;
+		std::atomic<uint8_t> finished;
+		// written by the trace writer
+		alignas(64) std::atomic<uint64_t> tail;
+		// read-only
+		alignas(64) uint64_t mask;
+		trace_entry entries[0];
+
+		inline void record(uint64_t target, uint64_t actual, uint32_t retries) {
+			uint64_t h = head.load(std::memory_order_relaxed);
+			if (h - cached_tail > mask) {
+				cached_tail = tail.load(std::memory_order_acquire);
+				if (h - cached_tail > mask) {
+					dropped++;
+					return;
+				}
+			}
+			int64_t error = (int64_t) (actual - target);
+			error = std::max<int64_t>(std::min<int64_t>(error, INT32_MAX), INT32_MIN);
+			entries[h & mask] = {target, (int32_t) error, retries};
+			head.store(h + 1, std::memory_order_release);
+		}
+	};
+
+	// header of trace files, the dropped and entries fields are updated when the file is closed
+	struct trace_file_header {
+		char magic[8];
+		uint32_t version;
+		uint32_t entry_size;
+		uint64_t tsc_hz;
+		uint64_t seed;
+		uint64_t entries;
+		uint64_t dropped;
+	};
+
 	struct limiter_control {
 		std::atomic<uint64_t> count = {0};
 		std::atomic<uint8_t> stop = {0};
+		limiter_trace* trace = nullptr;
+		uint64_t seed = 0;
 
 		inline bool running() {
 			return libmoon::is_running(0) && !stop.load(std::memory_order_relaxed);
@@ -38,7 +94,93 @@ namespace rate_limiter {
 		inline void count_packets(uint64_t n) {
 			count.fetch_add(n, std::memory_order_relaxed);
 		};
+
+		// call right after the packet was sent, the actual departure time is read here
+		inline void trace_packet(uint64_t target, uint32_t retries) {
+			if (trace) {
+				trace->record(target, rte_get_tsc_cycles(), retries);
+			}
+		};
+
+		inline void finish() {
+			if (trace) {
+				trace->finished.store(1, std::memory_order_release);
+			}
+		};
 	};
+
+	static limiter_trace* trace_create(uint32_t size) {
+		// round up to a power of two
+		uint64_t entries = 1;
+		while (entries < size) {
+			entries *= 2;
+		}
+		limiter_trace* trace = (limiter_trace*) rte_zmalloc("limiter_trace", sizeof(limiter_trace) + entries * sizeof(trace_entry), 64);
+		if (trace) {
+			trace->mask = entries - 1;
+		}
+		return trace;
+	}
+
+	// write all available entries, n is set to the number of entries written, returns false on write errors
+	static bool trace_drain(limiter_trace* trace, FILE* file, uint64_t& n) {
+		uint64_t t = trace->tail.load(std::memory_order_relaxed);
+		uint64_t h = trace->head.load(std::memory_order_acquire);
+		n = h - t;
+		if (n) {
+			uint64_t start = t & trace->mask;
+			// ring might wrap around
+			uint64_t first = std::min(n, trace->mask + 1 - start);
+			if (fwrite(trace->entries + start, sizeof(trace_entry), first, file) != first
+			 || fwrite(trace->entries, sizeof(trace_entry), n - first, file) != n - first) {
+				n = 0;
+				return false;
+			}
+			trace->tail.store(h, std::memory_order_release);
+		}
+		return true;
+	}
+
+	/*
+	 * Write the trace of a rate limiter to a file until the rate limiter is finished
+	 * The trace is freed afterwards, returns false if the file could not be written completely.
+	 */
+	static bool trace_write(limiter_trace* trace, uint64_t seed, const char* path) {
+		FILE* file = fopen(path, "wb");
+		trace_file_header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "MGTRACE", 8);
+		header.version = 1;
+		header.entry_size = sizeof(trace_entry);
+		header.tsc_hz = rte_get_tsc_hz();
+		header.seed = seed;
+		bool ok = file && fwrite(&header, sizeof(header), 1, file) == 1;
+		// on errors, keep waiting as the rate limiter uses the trace until it is finished
+		while (true) {
+			// check before draining to not miss entries written right before finishing
+			bool finished = trace->finished.load(std::memory_order_acquire);
+			uint64_t n = 0;
+			if (ok) {
+				ok = trace_drain(trace, file, n);
+				header.entries += n;
+			}
+			if (!n) {
+				if (finished) {
+					break;
+				}
+				usleep(1000);
+			}
+		}
+		header.dropped = trace->dropped;
+		rte_free(trace);
+		if (ok) {
+			ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+		}
+		if (file && fclose(file) != 0) {
+			ok = false;
+		}
+		return ok;
+	}
 	
 	/*
 	 * Arbitrary time software rate control main
@@ -58,17 +200,25 @@ namespace rate_limiter {
 				cur_batch_size /= 2;
 				n = ring_dequeue(ring, reinterpret_cast<void**>(bufs), cur_batch_size);
 			}
+			cur = rte_get_tsc_cycles();
+			// nothing sent for 10 ms, restart rate control
+			if (((int64_t) cur - (int64_t) next_send) > (int64_t) tsc_hz / 100) {
+				next_send = cur;
+			}
 			if (n) {
 				for (int i = 0; i < cur_batch_size; i++) {
 					// desired inter-frame spacing is encoded in the udata field (bytes on the wire)
 					id_cycles = ((uint64_t) bufs[i]->udata64 * 8 / link_bps) * tsc_hz;
 					next_send += id_cycles;
 					while ((cur = rte_get_tsc_cycles()) < next_send);
+					uint32_t retries = 0;
 					while (rte_eth_tx_burst(device, queue, bufs + i, 1) == 0) {
+						retries++;
 						if (!ctl->running()) {
 							return;
 						}
 					}
+					ctl->trace_packet(next_send, retries);
 				}
 				ctl->count_packets(n);
 			} else if (!ctl->running()) {
@@ -81,7 +231,7 @@ namespace rate_limiter {
 	static inline void main_loop_poisson(struct rte_ring* ring, uint8_t device, uint16_t queue, uint32_t target, uint32_t link_speed, limiter_control* ctl) {
 		uint64_t tsc_hz = rte_get_tsc_hz();
 		// control IPGs instead of IDT as IDTs < packet_time are physically impossible
-		std::default_random_engine rand;
+		std::default_random_engine rand(ctl->seed);
 		uint64_t next_send = 0;
 		struct rte_mbuf* bufs[batch_size];
 		while (libmoon::is_running(0)) {
@@ -98,14 +248,18 @@ namespace rate_limiter {
 					pkt_time *= (double) tsc_hz / 1000000000.0;
 					int64_t avg = (int64_t) (tsc_hz / (1000000000.0 / target) - pkt_time);
 					while ((cur = rte_get_tsc_cycles()) < next_send);
+					uint64_t target_tsc = next_send;
 					std::exponential_distribution<double> distribution(1.0 / avg);
 					double delay = (avg <= 0) ? 0 : distribution(rand);
 					next_send += pkt_time + delay;
+					uint32_t retries = 0;
 					while (rte_eth_tx_burst(device, queue, bufs + i, 1) == 0) {
+						retries++;
 						if (!ctl->running()) {
 							return;
 						}
 					}
+					ctl->trace_packet(target_tsc, retries);
 				}
 				ctl->count_packets(n);
 			} else if (!ctl->running()) {
@@ -129,13 +283,17 @@ namespace rate_limiter {
 			if (n) {
 				for (int i = 0; i < n; i++) {
 					while ((cur = rte_get_tsc_cycles()) < next_send);
+					uint64_t target_tsc = next_send;
 					next_send += id_cycles;
+					uint32_t retries = 0;
 					while (rte_eth_tx_burst(device, queue, bufs + i, 1) == 0) {
+						retries++;
 						// mellanox nics like to not accept packets when stopping for... reasons
 						if (!ctl->running()) {
 							return;
 						}
 					}
+					ctl->trace_packet(target_tsc, retries);
 				}
 				ctl->count_packets(n);
 			} else if (!ctl->running()) {
@@ -148,14 +306,25 @@ namespace rate_limiter {
 extern "C" {
 	void mg_rate_limiter_cbr_main_loop(rte_ring* ring, uint8_t device, uint16_t queue, uint32_t target, rate_limiter::limiter_control* ctl) {
 		rate_limiter::main_loop_cbr(ring, device, queue, target, ctl);
+		ctl->finish();
 	}
 
 	void mg_rate_limiter_poisson_main_loop(rte_ring* ring, uint8_t device, uint16_t queue, uint32_t target, uint32_t link_speed, rate_limiter::limiter_control* ctl) {
 		rate_limiter::main_loop_poisson(ring, device, queue, target, link_speed, ctl);
+		ctl->finish();
 	}
 
 	void mg_rate_limiter_main_loop(rte_ring* ring, uint8_t device, uint16_t queue, uint32_t link_speed, rate_limiter::limiter_control* ctl) {
 		rate_limiter::main_loop(ring, device, queue, link_speed, ctl);
+		ctl->finish();
+	}
+
+	rate_limiter::limiter_trace* mg_rate_limiter_trace_create(uint32_t size) {
+		return rate_limiter::trace_create(size);
+	}
+
+	bool mg_rate_limiter_trace_write(rate_limiter::limiter_trace* trace, uint64_t seed, const char* path) {
+		return rate_limiter::trace_write(trace, seed, path);
 	}
 }
 
@@ -0,0 +1,26 @@
+imix(12)
+imix"xyz"
+imix"aaxg"
+imix"AAG"
+sizeMix"abc"
+sizeMix{}
+sizeMix{[60] = -1}
+sizeMix{[60] = "a"}
+sizeMix{[60] = 1/0}
+sizeMix{[60] = 0/0}
+sizeMix{[60] = 0}
+sizeMix{[0] = 1}
+sizeMix{[60.5] = 1}
+sizeCdf{}
+sizeCdf"missing.cdf"
+sizeCdf"decreasing.cdf"
+sizeCdf"format.cdf"
+sizeCdf"infinite.cdf"
+
+Flow{"s1", Packet.Udp{
+	pktLength = sizeMix{[20] = 1, [60] = 1}
+}}
+
+Flow{"s2", Packet.Udp{
+	pktLength = sizeMix{[60] = 1, [4000] = 1}
+}}